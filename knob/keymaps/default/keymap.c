@@ -13,11 +13,10 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 // clang-format on
 
 void keyboard_pre_init_user(void) {
-    knob_config_t config = {
-        .mode = KNOB_MODE_WHEEL_VERTICAL,
-        .sensitivity = 8,
-        .acceleration = true,
-        .reverse = false,
-    };
+    knob_config_t config = default_knob_config;
+    config.mode = KNOB_MODE_WHEEL_VERTICAL;
+    config.sensitivity = 8;
+    config.acceleration = true;
+    config.reverse = false;
     set_knob_config(config);
 }
@@ -16,28 +16,28 @@ void colormap(int index, bool on) {
     uint8_t val = on ? RGBLIGHT_LIMIT_VAL : (RGBLIGHT_LIMIT_VAL >> 2);
     switch (index) {
         case 0:
-            rgblight_sethsv_noeeprom(0, 255, val);
+            knob_rgb_sethsv(0, 255, val);
             return;
         case 1:
-            rgblight_sethsv_noeeprom(12, 255, val);
+            knob_rgb_sethsv(12, 255, val);
             return;
         case 2:
-            rgblight_sethsv_noeeprom(35, 255, val);
+            knob_rgb_sethsv(35, 255, val);
             return;
         case 3:
-            rgblight_sethsv_noeeprom(80, 255, val);
+            knob_rgb_sethsv(80, 255, val);
             return;
         case 4:
-            rgblight_sethsv_noeeprom(105, 255, val);
+            knob_rgb_sethsv(105, 255, val);
             return;
         case 5:
-            rgblight_sethsv_noeeprom(165, 255, val);
+            knob_rgb_sethsv(165, 255, val);
             return;
         case 6:
-            rgblight_sethsv_noeeprom(185, 255, val);
+            knob_rgb_sethsv(185, 255, val);
             return;
         case 7:
-            rgblight_sethsv_noeeprom(215, 255, val);
+            knob_rgb_sethsv(215, 255, val);
             return;
         default:
             return;
@@ -47,15 +47,14 @@ void colormap(int index, bool on) {
 void keyboard_pre_init_user(void) {
 
     // set knob settings
-    knob_config_t config = {
-        .mode = KNOB_MODE_MIDI,
-        .sensitivity = 128,
-        .acceleration = false,
-        .reverse = false,
-        .midi_channel = 0,
-        .midi_cc = 0,
-        .midi_mode = MIDI_MODE_SIGNED
-    };
+    knob_config_t config = default_knob_config;
+    config.mode = KNOB_MODE_MIDI;
+    config.sensitivity = 128;
+    config.acceleration = false;
+    config.reverse = false;
+    config.midi_channel = 0;
+    config.midi_cc = 0;
+    config.midi_mode = MIDI_MODE_SIGNED;
     set_knob_config(config);
 
     // initialize rgb
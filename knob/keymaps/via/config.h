@@ -4,7 +4,7 @@
 #pragma once
 
 #define DYNAMIC_KEYMAP_LAYER_COUNT 8
-#define VIA_EEPROM_CUSTOM_CONFIG_SIZE 256
+#define VIA_EEPROM_CUSTOM_CONFIG_SIZE 384
 
 #define RGBLIGHT_EFFECT_BREATHING
 #define RGBLIGHT_EFFECT_RAINBOW_MOOD
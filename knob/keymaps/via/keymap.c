@@ -41,15 +41,33 @@ enum value_ids {
     id_drag_modifiers           = 8,
     id_midi_channel             = 9,
     id_midi_cc                  = 10,
-    LAYER_CONFIG_8_SIZE         = 11,
-
-    id_backlight_color          = 11,
-    id_encoder_keycode_cw       = 13,
-    id_encoder_keycode_ccw      = 15,
-    LAYER_CONFIG_SIZE           = 17,
-
-    id_midi_mode                = 17,
-    GLOBAL_CONFIG_SIZE          = 18 - LAYER_CONFIG_SIZE,
+    id_backlight_reactive       = 11,
+    id_throttle                 = 12,
+    id_timeout                  = 13,
+    id_acceleration_scale       = 14,
+    id_acceleration_blend       = 15,
+    id_drag_on_delay            = 16,
+    id_drag_off_delay           = 17,
+    id_dual_rate                = 18,
+    id_dual_rate_threshold      = 19,
+    id_dual_rate_fine_gain      = 20,
+    id_dual_rate_coarse_gain    = 21,
+    id_momentum                 = 22,
+    id_momentum_friction        = 23,
+    id_momentum_threshold       = 24,
+    id_sink_mode                = 25,
+    id_sink_sensitivity         = 26,
+    id_sink_reverse             = 27,
+    id_sink_pace                = 28,
+    LAYER_CONFIG_8_SIZE         = 29,
+
+    id_backlight_color          = 29,
+    id_encoder_keycode_cw       = 31,
+    id_encoder_keycode_ccw      = 33,
+    LAYER_CONFIG_SIZE           = 35,
+
+    id_midi_mode                = 35,
+    GLOBAL_CONFIG_SIZE          = 36 - LAYER_CONFIG_SIZE,
 
 };
 
@@ -76,11 +94,20 @@ void update_active_config(void) {
     knob_config.sensitivity = custom_config.layers[highest_layer][id_sensitivity] + 1;
     knob_config.acceleration = custom_config.layers[highest_layer][id_acceleration];
     knob_config.reverse = custom_config.layers[highest_layer][id_reverse];
+    knob_config.throttle_ms = custom_config.layers[highest_layer][id_throttle];
+    knob_config.timeout_ms = custom_config.layers[highest_layer][id_timeout] * 10;
+    knob_config.acceleration_scale = custom_config.layers[highest_layer][id_acceleration_scale];
+    knob_config.acceleration_blend = custom_config.layers[highest_layer][id_acceleration_blend] / 255.0;
+    knob_config.dual_rate = custom_config.layers[highest_layer][id_dual_rate];
+    knob_config.dual_rate_threshold = custom_config.layers[highest_layer][id_dual_rate_threshold] * 16;
+    knob_config.dual_rate_fine_gain = custom_config.layers[highest_layer][id_dual_rate_fine_gain] / 16.0;
+    knob_config.dual_rate_coarse_gain = custom_config.layers[highest_layer][id_dual_rate_coarse_gain] / 16.0;
     if (custom_config.layers[highest_layer][id_backlight]) {
-        rgblight_enable_noeeprom();
-        rgblight_sethsv_noeeprom(custom_config.layers[highest_layer][id_backlight_color], custom_config.layers[highest_layer][id_backlight_color + 1], rgblight_get_val());
+        knob_rgb_enable(true);
+        knob_rgb_sethsv(custom_config.layers[highest_layer][id_backlight_color], custom_config.layers[highest_layer][id_backlight_color + 1], rgblight_get_val());
+        knob_config.rgb_reactive = custom_config.layers[highest_layer][id_backlight_reactive];
     } else {
-        rgblight_disable_noeeprom();
+        knob_rgb_enable(false);
     }
 
     switch (custom_config.layers[highest_layer][id_mode]) {
@@ -100,6 +127,9 @@ void update_active_config(void) {
         // scroll wheel
         case 2:
             knob_config.mode = KNOB_MODE_WHEEL_VERTICAL + custom_config.layers[highest_layer][id_scroll_direction];
+            knob_config.momentum = custom_config.layers[highest_layer][id_momentum];
+            knob_config.momentum_friction = custom_config.layers[highest_layer][id_momentum_friction];
+            knob_config.momentum_threshold = custom_config.layers[highest_layer][id_momentum_threshold];
             break;
 
         // mouse drag (automatic)
@@ -107,6 +137,8 @@ void update_active_config(void) {
             knob_config.mode = KNOB_MODE_ADAPTIVE_DRAG_VERTICAL + custom_config.layers[highest_layer][id_drag_direction];
             knob_config.drag_button = custom_config.layers[highest_layer][id_drag_button];
             knob_config.drag_modifiers = custom_config.layers[highest_layer][id_drag_modifiers];
+            knob_config.drag_on_delay = custom_config.layers[highest_layer][id_drag_on_delay];
+            knob_config.drag_off_delay = custom_config.layers[highest_layer][id_drag_off_delay];
             break;
 
         // mouse drag (always on)
@@ -125,6 +157,34 @@ void update_active_config(void) {
             break;
     }
 
+    // a second output driven by the same turn
+    knob_sink_config_t *sink = &knob_config.sinks[0];
+    sink->sensitivity = custom_config.layers[highest_layer][id_sink_sensitivity] + 1;
+    sink->reverse = custom_config.layers[highest_layer][id_sink_reverse];
+    sink->pace_ms = custom_config.layers[highest_layer][id_sink_pace];
+    switch (custom_config.layers[highest_layer][id_sink_mode]) {
+
+        // encoder
+        case 1:
+            sink->mode = KNOB_MODE_ENCODER;
+            encoder_keycode_cw = custom_config.layers[highest_layer][id_encoder_keycode_cw] << 8 | custom_config.layers[highest_layer][id_encoder_keycode_cw + 1];
+            encoder_keycode_ccw = custom_config.layers[highest_layer][id_encoder_keycode_ccw] << 8 | custom_config.layers[highest_layer][id_encoder_keycode_ccw + 1];
+            break;
+
+        // scroll wheel
+        case 2:
+            sink->mode = KNOB_MODE_WHEEL_VERTICAL + custom_config.layers[highest_layer][id_scroll_direction];
+            break;
+
+        // midi relative cc
+        case 3:
+            sink->mode = KNOB_MODE_MIDI;
+            knob_config.midi_channel = custom_config.layers[highest_layer][id_midi_channel];
+            knob_config.midi_cc = custom_config.layers[highest_layer][id_midi_cc];
+            knob_config.midi_mode = custom_config.global[id_midi_mode - LAYER_CONFIG_SIZE];
+            break;
+    }
+
     // write the constructed config
     set_knob_config(knob_config);
 }
@@ -199,6 +259,21 @@ void keyboard_post_init_user(void) {
 void eeconfig_init_user(void) {
     memset(&custom_config, 0, sizeof(custom_config_t));
 
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        custom_config.layers[layer][id_throttle] = KNOB_THROTTLE_MS;
+        custom_config.layers[layer][id_timeout] = KNOB_TIMEOUT_MS / 10;
+        custom_config.layers[layer][id_acceleration_scale] = KNOB_ACCELERATION_SCALE;
+        custom_config.layers[layer][id_acceleration_blend] = KNOB_ACCELERATION_BLEND * 255 + 0.5;
+        custom_config.layers[layer][id_drag_on_delay] = KNOB_ADAPTIVE_DRAG_ON_DELAY;
+        custom_config.layers[layer][id_drag_off_delay] = KNOB_ADAPTIVE_DRAG_OFF_DELAY;
+        custom_config.layers[layer][id_dual_rate_threshold] = KNOB_DUAL_RATE_THRESHOLD / 16;
+        custom_config.layers[layer][id_dual_rate_fine_gain] = KNOB_DUAL_RATE_FINE_GAIN * 16;
+        custom_config.layers[layer][id_dual_rate_coarse_gain] = KNOB_DUAL_RATE_COARSE_GAIN * 16;
+        custom_config.layers[layer][id_momentum_friction] = KNOB_MOMENTUM_FRICTION;
+        custom_config.layers[layer][id_momentum_threshold] = KNOB_MOMENTUM_THRESHOLD;
+        custom_config.layers[layer][id_sink_sensitivity] = KNOB_VIA_DEFAULT_SENS_0;
+    }
+
     custom_config.layers[0][id_mode] = KNOB_MODE_ENCODER;
     custom_config.layers[0][id_backlight] = 1;
     custom_config.layers[0][id_sensitivity] = KNOB_VIA_DEFAULT_SENS_0;
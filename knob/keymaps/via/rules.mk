@@ -3,4 +3,5 @@ ENCODER_ENABLE = yes
 MIDI_ENABLE = yes
 EXTRAKEY_ENABLE = yes
 RGBLIGHT_ENABLE = yes
-VIA_ENABLE = yes
\ No newline at end of file
+VIA_ENABLE = yes
+KNOB_CALIBRATION_ENABLE = yes
\ No newline at end of file
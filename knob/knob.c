@@ -25,35 +25,140 @@
 int16_t as5600_raw = 0;
 int16_t as5600_delta = 0;
 
-static void housekeeping_task_read_as5600(void) {
+// the same angle with KNOB_FRACTION_BITS of sub-count resolution
+int32_t as5600_raw_fine = 0;
+int32_t as5600_delta_fine = 0;
+
+#define AS5600_FINE_RANGE ((int32_t)4096 << KNOB_FRACTION_BITS)
+
+// simulated backlash for debouncing, then the wrapped delta from the previous raw angle
+static void as5600_filter_sample(int32_t sample, int32_t* raw, int32_t* delta) {
 
     // save previous raw angle
-    int16_t as5600_raw_prev = as5600_raw;
-    
-    // read raw angle
-    uint8_t buffer[2];
-    i2c_read_register(AS5600_DEV_ADDR, AS5600_REG_ADDR, buffer, AS5600_LENGTH, AS5600_TIMEOUT);
-    int16_t as5600_raw_noisy = AS5600_MASK & (((int16_t)buffer[0] << 8) | buffer[1]);
+    int32_t raw_prev = *raw;
 
     // simulated backlash for debouncing
-    int16_t as5600_delta_noisy = as5600_raw_noisy - as5600_raw_prev;
-    if (as5600_delta_noisy >= 2048) {
-        as5600_delta_noisy -= 4096;
-    } else if (as5600_delta_noisy < -2048) {
-        as5600_delta_noisy += 4096;
+    int32_t delta_noisy = sample - raw_prev;
+    if (delta_noisy >= AS5600_FINE_RANGE / 2) {
+        delta_noisy -= AS5600_FINE_RANGE;
+    } else if (delta_noisy < -AS5600_FINE_RANGE / 2) {
+        delta_noisy += AS5600_FINE_RANGE;
     }
-    if (as5600_delta_noisy > 1) {
-        as5600_raw = as5600_raw_noisy - 1;
-    } else if (as5600_delta_noisy < -1) {
-        as5600_raw = as5600_raw_noisy + 1;
+    if (delta_noisy > KNOB_BACKLASH) {
+        *raw = sample - KNOB_BACKLASH;
+    } else if (delta_noisy < -KNOB_BACKLASH) {
+        *raw = sample + KNOB_BACKLASH;
     }
-    if (as5600_raw >= 4096) {
-        as5600_raw -= 4096;
-    } else if (as5600_raw < 0) {
-        as5600_raw += 4096;
+    if (*raw >= AS5600_FINE_RANGE) {
+        *raw -= AS5600_FINE_RANGE;
+    } else if (*raw < 0) {
+        *raw += AS5600_FINE_RANGE;
     }
 
     // compute delta
+    *delta = *raw - raw_prev;
+    if (*delta >= AS5600_FINE_RANGE / 2) {
+        *delta -= AS5600_FINE_RANGE;
+    } else if (*delta < -AS5600_FINE_RANGE / 2) {
+        *delta += AS5600_FINE_RANGE;
+    }
+}
+
+#ifdef KNOB_OVERSAMPLE_ENABLE
+
+typedef struct {
+    int16_t first;
+    int32_t sum;
+    uint8_t count;
+} as5600_decimator_t;
+
+as5600_decimator_t as5600_decimator = {0};
+
+// averages 2^KNOB_OVERSAMPLE_SHIFT samples into one angle with KNOB_FRACTION_BITS
+// of fraction; samples are unwrapped against the first one so the mean is
+// correct across the 4095 -> 0 boundary
+static bool as5600_decimate(as5600_decimator_t* decimator, int16_t sample, int32_t* sample_fine) {
+    if (decimator->count == 0) {
+        decimator->first = sample;
+        decimator->sum = 0;
+    }
+    int16_t offset = sample - decimator->first;
+    if (offset >= 2048) {
+        offset -= 4096;
+    } else if (offset < -2048) {
+        offset += 4096;
+    }
+    decimator->sum += offset;
+    if (++decimator->count < (1 << KNOB_OVERSAMPLE_SHIFT)) {
+        return false;
+    }
+    decimator->count = 0;
+
+    // mean offset in fine units, rounded
+    int32_t mean = (((int32_t)decimator->sum << KNOB_FRACTION_BITS) + (1 << (KNOB_OVERSAMPLE_SHIFT - 1))) >> KNOB_OVERSAMPLE_SHIFT;
+    *sample_fine = ((int32_t)decimator->first << KNOB_FRACTION_BITS) + mean;
+    if (*sample_fine >= AS5600_FINE_RANGE) {
+        *sample_fine -= AS5600_FINE_RANGE;
+    } else if (*sample_fine < 0) {
+        *sample_fine += AS5600_FINE_RANGE;
+    }
+    return true;
+}
+
+#endif // KNOB_OVERSAMPLE_ENABLE
+
+#ifdef KNOB_CALIBRATION_ENABLE
+
+// angle error at each bin boundary in fine units, as fitted by the calibration;
+// all zero (a fresh eeprom) means no correction
+int16_t as5600_correction[KNOB_CAL_BINS] = {0};
+volatile bool as5600_correction_enabled = true;
+
+#    define AS5600_CAL_BIN_SHIFT (12 + KNOB_FRACTION_BITS - KNOB_CAL_BINS_SHIFT)
+
+// subtracts the error, interpolated between the two surrounding bin boundaries
+static int32_t as5600_linearize(int32_t sample) {
+    if (!as5600_correction_enabled) {
+        return sample;
+    }
+    uint8_t bin = sample >> AS5600_CAL_BIN_SHIFT;
+    int32_t fraction = sample & ((1 << AS5600_CAL_BIN_SHIFT) - 1);
+    int32_t low = as5600_correction[bin];
+    int32_t high = as5600_correction[(bin + 1) & (KNOB_CAL_BINS - 1)];
+    sample -= low + (((high - low) * fraction) >> AS5600_CAL_BIN_SHIFT);
+    if (sample >= AS5600_FINE_RANGE) {
+        sample -= AS5600_FINE_RANGE;
+    } else if (sample < 0) {
+        sample += AS5600_FINE_RANGE;
+    }
+    return sample;
+}
+
+#endif // KNOB_CALIBRATION_ENABLE
+
+static void housekeeping_task_read_as5600(void) {
+    // read raw angle
+    uint8_t buffer[2];
+    i2c_read_register(AS5600_DEV_ADDR, AS5600_REG_ADDR, buffer, AS5600_LENGTH, AS5600_TIMEOUT);
+    int16_t as5600_raw_noisy = AS5600_MASK & (((int16_t)buffer[0] << 8) | buffer[1]);
+#ifdef KNOB_OVERSAMPLE_ENABLE
+    int32_t as5600_raw_noisy_fine;
+    if (!as5600_decimate(&as5600_decimator, as5600_raw_noisy, &as5600_raw_noisy_fine)) {
+        as5600_delta_fine = 0;
+        as5600_delta = 0;
+        return;
+    }
+#else
+    int32_t as5600_raw_noisy_fine = as5600_raw_noisy;
+#endif // KNOB_OVERSAMPLE_ENABLE
+#ifdef KNOB_CALIBRATION_ENABLE
+    as5600_raw_noisy_fine = as5600_linearize(as5600_raw_noisy_fine);
+#endif // KNOB_CALIBRATION_ENABLE
+    as5600_filter_sample(as5600_raw_noisy_fine, &as5600_raw_fine, &as5600_delta_fine);
+
+    // whole-count view of the same angle
+    int16_t as5600_raw_prev = as5600_raw;
+    as5600_raw = as5600_raw_fine >> KNOB_FRACTION_BITS;
     as5600_delta = as5600_raw - as5600_raw_prev;
     if (as5600_delta >= 2048) {
         as5600_delta -= 4096;
@@ -62,6 +167,284 @@ static void housekeeping_task_read_as5600(void) {
     }
 }
 
+// ============================================================================
+// KNOB CALIBRATION
+// ============================================================================
+
+#ifdef KNOB_CALIBRATION_ENABLE
+
+_Static_assert(EECONFIG_KB_DATA_SIZE >= sizeof(as5600_correction), "EECONFIG_KB_DATA_SIZE too small for the correction table");
+
+// the knob is turned at a roughly steady speed, so the true angle follows the
+// time; the error at a bin boundary is how far the sensor had turned when it
+// crossed it, minus how far it should have turned in that time
+typedef struct {
+    bool active;
+    int8_t direction;
+    uint8_t start_bin;
+    uint8_t crossings;
+    uint8_t turns;
+    int32_t position;
+    int32_t boundary;
+    uint32_t turn_start_time;
+    uint32_t last_crossing_time;
+    uint16_t last_turn_time;  // 0 until a steady turn has set the speed reference
+    uint16_t crossing_times[KNOB_CAL_BINS];
+    int32_t error_sums[KNOB_CAL_BINS];
+} knob_calibration_state_t;
+
+knob_calibration_state_t knob_calibration_state = {0};
+
+#    ifndef KNOB_MINIMAL
+// the outputs are let go of for the whole calibration
+static void knob_release_outputs(void);
+static void knob_engage_outputs(void);
+#    endif  // !KNOB_MINIMAL
+
+static void knob_calibration_load(void) {
+    eeconfig_read_kb_datablock(as5600_correction, 0, sizeof(as5600_correction));
+}
+
+void knob_calibration_start(void) {
+    memset(&knob_calibration_state, 0, sizeof(knob_calibration_state));
+    knob_calibration_state.active = true;
+    knob_calibration_state.position = as5600_raw_fine;
+    knob_calibration_state.boundary = as5600_raw_fine >> AS5600_CAL_BIN_SHIFT;
+    knob_calibration_state.last_crossing_time = timer_read32();
+
+    // fit against the uncorrected angle
+    as5600_correction_enabled = false;
+
+#    ifndef KNOB_MINIMAL
+    knob_release_outputs();
+#        ifdef RGBLIGHT_ENABLE
+    knob_rgb_flash(KNOB_CAL_HUE_START);
+#        endif  // RGBLIGHT_ENABLE
+#    endif  // !KNOB_MINIMAL
+}
+
+static void knob_calibration_stop(bool save) {
+    knob_calibration_state.active = false;
+    if (save) {
+        for (uint8_t i = 0; i < KNOB_CAL_BINS; i++) {
+            int32_t correction = knob_calibration_state.error_sums[i] / KNOB_CAL_TURNS;
+            as5600_correction[i] = correction > INT16_MAX ? INT16_MAX : correction < INT16_MIN ? INT16_MIN : correction;
+        }
+        eeconfig_update_kb_datablock(as5600_correction, 0, sizeof(as5600_correction));
+        dprintf("knob cal table:");
+        for (uint8_t i = 0; i < KNOB_CAL_BINS; i++) {
+            dprintf(" %d", as5600_correction[i]);
+        }
+        dprintf("\n");
+    } else {
+        dprintf("knob cal: aborted\n");
+    }
+    as5600_correction_enabled = true;
+
+#    ifndef KNOB_MINIMAL
+    knob_engage_outputs();
+#        ifdef RGBLIGHT_ENABLE
+    knob_rgb_flash(save ? KNOB_CAL_HUE_DONE : KNOB_CAL_HUE_ABORT);
+#        endif  // RGBLIGHT_ENABLE
+#    endif  // !KNOB_MINIMAL
+}
+
+// error at the turn's nth crossing, in fine units; the speed is taken to change
+// at a constant rate over the turn, so that with x the fraction of the turn's
+// time, the true angle is x + trend * x * (x - 1) turns
+static int32_t knob_calibration_error(uint8_t crossing, uint16_t turn_time, float trend) {
+    int32_t measured = (int32_t)crossing << AS5600_CAL_BIN_SHIFT;
+    float x = (float)knob_calibration_state.crossing_times[crossing] / turn_time;
+    int32_t expected = AS5600_FINE_RANGE * (x + trend * x * (x - 1.0f));
+    return knob_calibration_state.direction * (measured - expected);
+}
+
+static bool knob_calibration_steady(uint16_t time, uint16_t nominal) {
+    uint32_t tolerance = (uint32_t)nominal * KNOB_CAL_STEADY_PERCENT / 100;
+    return time + tolerance >= nominal && time <= nominal + tolerance;
+}
+
+// adds one turn's errors, less their mean, which is only the constant offset
+// of where the turn started. the periodic error evens out over a whole turn,
+// so the trend comes from this turn's and the previous turn's durations; the
+// first steady turn only sets that reference. a turn with any bin, or its
+// whole duration, off the expected time by more than KNOB_CAL_STEADY_PERCENT
+// is rejected
+static bool knob_calibration_fit_turn(uint16_t turn_time) {
+    uint16_t bin_time = turn_time / KNOB_CAL_BINS;
+    for (uint8_t i = 0; i < KNOB_CAL_BINS; i++) {
+        uint16_t next = i + 1 < KNOB_CAL_BINS ? knob_calibration_state.crossing_times[i + 1] : turn_time;
+        uint16_t interval = next - knob_calibration_state.crossing_times[i];
+        if (!knob_calibration_steady(interval, bin_time)) {
+            dprintf("knob cal: uneven turn\n");
+            knob_calibration_state.last_turn_time = 0;
+            return false;
+        }
+    }
+    uint16_t previous = knob_calibration_state.last_turn_time;
+    knob_calibration_state.last_turn_time = turn_time;
+    if (previous == 0) {
+        return false;
+    }
+    if (!knob_calibration_steady(turn_time, previous)) {
+        dprintf("knob cal: speed changed\n");
+        return false;
+    }
+
+    // speed at the turn's end relative to its start is (1 + trend) / (1 - trend)
+    float trend = (float)((int32_t)previous - turn_time) * turn_time / ((float)previous * ((int32_t)previous + turn_time));
+    int32_t mean = 0;
+    for (uint8_t i = 0; i < KNOB_CAL_BINS; i++) {
+        mean += knob_calibration_error(i, turn_time, trend);
+    }
+    mean /= KNOB_CAL_BINS;
+    for (uint8_t i = 0; i < KNOB_CAL_BINS; i++) {
+        uint8_t bin = (knob_calibration_state.start_bin + knob_calibration_state.direction * i) & (KNOB_CAL_BINS - 1);
+        knob_calibration_state.error_sums[bin] += knob_calibration_error(i, turn_time, trend) - mean;
+    }
+    return true;
+}
+
+static void knob_calibration_cross(int32_t boundary, int8_t direction, uint32_t time) {
+    knob_calibration_state.last_crossing_time = time;
+
+    // a reversal throws away the partial turn and the speed reference
+    if (direction != knob_calibration_state.direction) {
+        knob_calibration_state.direction = direction;
+        knob_calibration_state.crossings = 0;
+        knob_calibration_state.last_turn_time = 0;
+    }
+    if (knob_calibration_state.crossings == 0) {
+        knob_calibration_state.start_bin = boundary & (KNOB_CAL_BINS - 1);
+        knob_calibration_state.turn_start_time = time;
+    }
+
+    // back at the first boundary, so the turn is complete
+    uint32_t turn_time = TIMER_DIFF_32(time, knob_calibration_state.turn_start_time);
+    if (turn_time > UINT16_MAX) {
+        knob_calibration_stop(false);
+        return;
+    }
+    if (knob_calibration_state.crossings == KNOB_CAL_BINS) {
+        if (knob_calibration_fit_turn(turn_time) && ++knob_calibration_state.turns == KNOB_CAL_TURNS) {
+            knob_calibration_stop(true);
+            return;
+        }
+        knob_calibration_state.crossings = 0;
+        knob_calibration_state.turn_start_time = time;
+        turn_time = 0;
+    }
+    knob_calibration_state.crossing_times[knob_calibration_state.crossings++] = turn_time;
+}
+
+// returns true while calibrating, when the knob's outputs are held
+static bool knob_calibration_task(void) {
+    if (!knob_calibration_state.active) {
+        return false;
+    }
+    uint32_t time = timer_read32();
+    if (TIMER_DIFF_32(time, knob_calibration_state.last_crossing_time) > KNOB_CAL_TIMEOUT_MS) {
+        knob_calibration_stop(false);
+        return false;
+    }
+    if (as5600_delta_fine == 0) {
+        return true;
+    }
+
+    // the unwrapped angle doubles as the trace for the host-side check
+    knob_calibration_state.position += as5600_delta_fine;
+    dprintf("knob cal trace: %lu %ld\n", time, knob_calibration_state.position);
+
+    // boundaries are crossed one at a time, even if a sample skipped over some
+    int32_t boundary = knob_calibration_state.position >> AS5600_CAL_BIN_SHIFT;
+    while (knob_calibration_state.active && knob_calibration_state.boundary < boundary) {
+        knob_calibration_cross(++knob_calibration_state.boundary, 1, time);
+    }
+    while (knob_calibration_state.active && knob_calibration_state.boundary > boundary) {
+        knob_calibration_cross(knob_calibration_state.boundary--, -1, time);
+    }
+    return true;
+}
+
+#endif // KNOB_CALIBRATION_ENABLE
+
+// ============================================================================
+// KNOB EVENTS
+// ============================================================================
+
+typedef struct {
+    int32_t velocity;
+    int32_t fraction;
+    int8_t direction;
+} knob_event_state_t;
+
+knob_event_state_t knob_event_state = {0};
+
+__attribute__((weak)) bool knob_event_user(knob_event_t* event) {
+    return true;
+}
+
+__attribute__((weak)) bool knob_event_kb(knob_event_t* event) {
+    return knob_event_user(event);
+}
+
+// builds the slot's event and hands it to the keymap; false if it was consumed
+static bool knob_event_emit(int32_t delta_fine, uint32_t time, uint32_t elapsed) {
+
+    // events carry whole counts, the fraction waits for the next slot
+    delta_fine += knob_event_state.fraction;
+    int16_t delta = delta_fine >> KNOB_FRACTION_BITS;
+    knob_event_state.fraction = delta_fine - ((int32_t)delta << KNOB_FRACTION_BITS);
+
+    knob_event_t event = {
+        .delta = delta,
+        .time = time,
+        .direction_changed = false,
+    };
+
+    // velocity is an exponential average of per-slot rates
+    int32_t rate = (int32_t)delta * 1000 / (elapsed > 0 ? elapsed : 1);
+    knob_event_state.velocity = (3 * knob_event_state.velocity + rate) / 4;
+    event.velocity = knob_event_state.velocity;
+
+    // track the last nonzero direction
+    if (delta != 0) {
+        int8_t direction = delta > 0 ? 1 : -1;
+        event.direction_changed = knob_event_state.direction != 0 && knob_event_state.direction != direction;
+        knob_event_state.direction = direction;
+    }
+
+    return knob_event_kb(&event);
+}
+
+#ifdef KNOB_MINIMAL
+
+typedef struct {
+    uint32_t last_event_time;
+    int32_t accumulator;
+} knob_minimal_state_t;
+
+knob_minimal_state_t knob_minimal_state = {0};
+
+// without the knob modes, accumulate sensor deltas and only deliver events
+static void housekeeping_task_knob_events(void) {
+    uint32_t current_time = timer_read32();
+    knob_minimal_state.accumulator += as5600_delta_fine;
+    uint32_t elapsed = TIMER_DIFF_32(current_time, knob_minimal_state.last_event_time);
+    if (elapsed < KNOB_THROTTLE_MS) {
+        return;
+    }
+    knob_minimal_state.last_event_time = current_time;
+    if (knob_minimal_state.accumulator == 0 && knob_event_state.velocity == 0) {
+        return;
+    }
+    int32_t delta_fine = knob_minimal_state.accumulator;
+    knob_minimal_state.accumulator = 0;
+    knob_event_emit(delta_fine, current_time, elapsed);
+}
+
+#endif // KNOB_MINIMAL
+
 uint16_t get_as5600_raw(void) {
     return as5600_raw;
 }
@@ -76,10 +459,6 @@ int16_t get_as5600_delta(void) {
 // ACCELERATION HELPERS
 // ============================================================================
 
-#    define ACCELERATION_CONST_P ((float) KNOB_ACCELERATION_BLEND / (float) KNOB_ACCELERATION_SCALE)
-#    define ACCELERATION_CONST_Q ((float) KNOB_ACCELERATION_BLEND + 1.0)
-#    define ACCELERATION_CONST_R ((float) KNOB_ACCELERATION_SCALE)
-
 typedef struct {
     float items[KNOB_ACCELERATION_BUFFER_SIZE];
     float current_sum;
@@ -120,19 +499,63 @@ typedef enum {
 } drag_state_t;
 #    endif  // POINTING_DEVICE_ENABLE
 
+// the main mode is sink 0, followed by the extra sinks from the config
+#    define KNOB_SINK_COUNT (1 + KNOB_EXTRA_SINKS)
+
+typedef struct {
+    float pending;
+    float remainder;
+    uint32_t last_output_time;
+    bool due;
+    bool moved;
+} knob_sink_state_t;
+
 typedef struct {
     uint32_t last_motion_time;
     uint32_t last_action_time;
-    int16_t accumulator;
-    float remainder;
+    int32_t accumulator;
+    uint16_t speed;
+    bool dual_rate_fine;
+    float dual_rate_blend;
+    float dual_rate_carry;
     ring_buffer_t acceleration_buffer;
+    knob_sink_state_t sinks[KNOB_SINK_COUNT];
 #    ifdef POINTING_DEVICE_ENABLE
     drag_state_t drag_state;
-    uint32_t drag_time; 
+    uint32_t drag_time;
+    uint32_t drag_motion_time;
+    uint16_t drag_interval;
+    int32_t drag_replay;
+    uint8_t drag_buttons;
+    uint8_t drag_buttons_reported;
+    bool momentum_coasting;
+    int32_t momentum_velocity;
+    int32_t momentum_position;
 #    endif  // POINTING_DEVICE_ENABLE
 } knob_state_t;
 
+// constants derived from the config, recomputed whenever the config is applied
+typedef struct {
+    float acceleration_p;
+    float acceleration_q;
+    float acceleration_r;
+    int32_t dual_rate_fine_speed;
+    int32_t dual_rate_coarse_speed;
+    float dual_rate_gain_span;
+    float dual_rate_blend_per_ms;
+#    ifdef POINTING_DEVICE_ENABLE
+    int32_t momentum_threshold;
+#    endif  // POINTING_DEVICE_ENABLE
+    knob_mode_t sink_mode[KNOB_SINK_COUNT];
+    float sink_scale[KNOB_SINK_COUNT];
+    uint16_t sink_pace_ms[KNOB_SINK_COUNT];
+    int8_t pointing_sink;  // -1 if no sink drives the pointing device
+    bool encoder_sink;     // its events are sent by the next loop's encoder task
+    bool active;
+} knob_params_t;
+
 knob_config_t knob_config = {0};
+knob_params_t knob_params = {0};
 knob_state_t knob_state = {0};
 uint32_t current_time = 0;
 
@@ -142,24 +565,28 @@ uint32_t current_time = 0;
 
 #    ifdef POINTING_DEVICE_ENABLE
 
+// the button itself is merged into the report by the pointing device driver below
 void start_dragging(void) {
-    report_mouse_t mouse = pointing_device_get_report();
-    mouse.buttons = pointing_device_handle_buttons(mouse.buttons, true, knob_config.drag_button);
-    pointing_device_set_report(mouse);
+    knob_state.drag_buttons = pointing_device_handle_buttons(0, true, knob_config.drag_button);
     if (knob_config.drag_modifiers != 0) {
         register_mods(knob_config.drag_modifiers);
     }
 }
 
 void stop_dragging(void) {
-    report_mouse_t mouse = pointing_device_get_report();
-    mouse.buttons = pointing_device_handle_buttons(mouse.buttons, false, knob_config.drag_button);
-    pointing_device_set_report(mouse);
+    knob_state.drag_buttons = 0;
     if (knob_config.drag_modifiers != 0) {
         unregister_mods(knob_config.drag_modifiers);
     }
 }
 
+static report_mouse_t drag_merge_buttons(report_mouse_t mouse) {
+    uint8_t released = knob_state.drag_buttons_reported & ~knob_state.drag_buttons;
+    mouse.buttons = (mouse.buttons & ~released) | knob_state.drag_buttons;
+    knob_state.drag_buttons_reported = knob_state.drag_buttons;
+    return mouse;
+}
+
 #    endif  // POINTING_DEVICE_ENABLE
 
 // ============================================================================
@@ -199,11 +626,37 @@ static void midi_send_relative_cc(int delta, uint8_t channel, uint8_t cc, midi_m
                 value = (uint8_t)(sign | mag);
                 break;
             }
+            case MIDI_MODE_ABSOLUTE_14:
+                return;  // not a relative mode
         }
     }
     midi_send_cc(&midi_device, channel, cc, value);
 }
 
+// 14-bit controllers pair cc (msb) with cc + 32 (lsb), msb first; the value
+// belongs to one channel and cc, any other starts over from center
+typedef struct {
+    int16_t value;
+    uint8_t channel;
+    uint8_t cc;
+} midi_value_14_t;
+
+midi_value_14_t midi_value_14 = {.value = 8192};
+
+static void midi_send_absolute_cc14(int delta, uint8_t channel, uint8_t cc) {
+    int32_t value = (int32_t)midi_value_14.value + delta;
+    if (value > 16383) value = 16383;
+    if (value < 0)     value = 0;
+    if (value == midi_value_14.value) {
+        return;
+    }
+    midi_value_14.value = value;
+    midi_send_cc(&midi_device, channel, cc, value >> 7);
+    if (cc < 32) {
+        midi_send_cc(&midi_device, channel, cc + 32, value & 0x7F);
+    }
+}
+
 #    endif  // MIDI_ENABLE
 
 // ============================================================================
@@ -214,41 +667,78 @@ void reset_knob_state(void) {
     knob_state.last_motion_time = current_time;
     knob_state.last_action_time = current_time;
     knob_state.accumulator = 0;
-    knob_state.remainder = 0;
+    knob_state.speed = 0;
+    knob_state.dual_rate_fine = true;
+    knob_state.dual_rate_blend = 0;
+    knob_state.dual_rate_carry = 0;
     ring_buffer_reset(&knob_state.acceleration_buffer);
+    for (uint8_t i = 0; i < KNOB_SINK_COUNT; i++) {
+        knob_state.sinks[i].pending = 0;
+        knob_state.sinks[i].remainder = 0;
+    }
 }
 
-static void housekeeping_task_knob_modes(void) {
-
-    // avoid repeated timer reads by doing it once and saving the value
-    current_time = timer_read32();
+// below the speed threshold the knob switches to reduced gain and extra
+// smoothing; blend crossfades between the two (0 = fine, 1 = coarse)
+static float knob_dual_rate(float delta, uint32_t elapsed) {
 
-    // skip everything if the knob is set to off
-    if (knob_config.mode == KNOB_MODE_OFF) {
-        return;
+    // switch rates with hysteresis around the threshold
+    int32_t speed = labs(knob_event_state.velocity);
+    if (knob_state.dual_rate_fine && speed > knob_params.dual_rate_coarse_speed) {
+        knob_state.dual_rate_fine = false;
+    } else if (!knob_state.dual_rate_fine && speed < knob_params.dual_rate_fine_speed) {
+        knob_state.dual_rate_fine = true;
     }
 
-    // reset state after a period of no activity
-    if (as5600_delta == 0) {
-        if (TIMER_DIFF_32(current_time, knob_state.last_motion_time) > KNOB_TIMEOUT_MS) {
-            reset_knob_state();
-            return;
-        }
+    // crossfade toward the active rate
+    float step = elapsed * knob_params.dual_rate_blend_per_ms;
+    if (knob_state.dual_rate_fine) {
+        knob_state.dual_rate_blend = knob_state.dual_rate_blend > step ? knob_state.dual_rate_blend - step : 0;
     } else {
-        knob_state.accumulator += as5600_delta;
-        knob_state.last_motion_time = current_time;
+        knob_state.dual_rate_blend = knob_state.dual_rate_blend + step < 1 ? knob_state.dual_rate_blend + step : 1;
     }
+    float blend = knob_state.dual_rate_blend;
+
+    // gain, then smoothing that releases a share of the carried motion each action
+    knob_state.dual_rate_carry += delta * (knob_config.dual_rate_fine_gain + blend * knob_params.dual_rate_gain_span);
+    float share = KNOB_DUAL_RATE_FINE_SMOOTHING + blend * (1.0f - KNOB_DUAL_RATE_FINE_SMOOTHING);
+    delta = knob_state.dual_rate_carry * share;
+    knob_state.dual_rate_carry -= delta;
+    return delta;
+}
+
+static bool is_pointing_mode(knob_mode_t mode) {
+#    ifdef POINTING_DEVICE_ENABLE
+    return (KNOB_MODE_WHEEL_VERTICAL <= mode) && (mode <= KNOB_MODE_ADAPTIVE_DRAG_DIAGONAL);
+#    else
+    return false;
+#    endif  // POINTING_DEVICE_ENABLE
+}
+
+// once an action is due, consumes the accumulator and hands the filtered,
+// accelerated motion to every sink; scaling and pacing are left to the sinks
+static void knob_action_slot(void) {
 
     // throttle rate at which actions are performed
-    if (TIMER_DIFF_32(current_time, knob_state.last_action_time) < KNOB_THROTTLE_MS) {
+    uint32_t elapsed = TIMER_DIFF_32(current_time, knob_state.last_action_time);
+    if (elapsed < knob_config.throttle_ms) {
         return;
     }
     knob_state.last_action_time = current_time;
 
-    // zero out the accumulator when ready to perform an action
-    float delta = knob_state.accumulator;
+    // smoothed counts per action, used by velocity-reactive lighting
+    knob_state.speed = (3 * knob_state.speed + (labs(knob_state.accumulator) >> KNOB_FRACTION_BITS)) / 4;
+
+    // zero out the accumulator when ready to perform an action, keeping the fraction
+    int32_t delta_fine = knob_state.accumulator;
+    float delta = delta_fine * KNOB_FRACTION_SCALE;
     knob_state.accumulator = 0;
 
+    // the keymap sees the slot first and may consume it
+    if (!knob_event_emit(delta_fine, current_time, elapsed)) {
+        return;
+    }
+
     // apply acceleration
     if (knob_config.acceleration) {
         float speed = fabsf(delta);
@@ -256,55 +746,57 @@ static void housekeeping_task_knob_modes(void) {
         if (delta != 0) {
             // v_out = p * square(min(v_in - r, 0)) + q * (v_in - r) + r
             speed = ring_buffer_mean(&knob_state.acceleration_buffer);
-            float speed_offset = speed - ACCELERATION_CONST_R;
-            float scale_factor = ACCELERATION_CONST_Q * speed_offset + ACCELERATION_CONST_R;
+            float speed_offset = speed - knob_params.acceleration_r;
+            float scale_factor = knob_params.acceleration_q * speed_offset + knob_params.acceleration_r;
             if (speed_offset < 0) {
-                scale_factor += ACCELERATION_CONST_P * speed_offset * speed_offset;
+                scale_factor += knob_params.acceleration_p * speed_offset * speed_offset;
             }
             scale_factor /= speed;
             delta *= scale_factor;
         }
     }
 
-    // apply sensitivity
-    switch (knob_config.mode) {
-        case KNOB_MODE_OFF:
-            return;  // unreachable
-#    ifdef ENCODER_ENABLE
-        case KNOB_MODE_ENCODER:
-            delta *= knob_config.sensitivity * KNOB_SENS_SCALE_ENCODER;
-            break;
-#    endif  // ENCODER_ENABLE
-#    ifdef POINTING_DEVICE_ENABLE
-        case KNOB_MODE_WHEEL_VERTICAL...KNOB_MODE_WHEEL_HORIZONTAL:
-            delta *= knob_config.sensitivity * KNOB_SENS_SCALE_WHEEL;
-            break;
-        case KNOB_MODE_DRAG_VERTICAL...KNOB_MODE_ADAPTIVE_DRAG_DIAGONAL:
-            delta *= knob_config.sensitivity * KNOB_SENS_SCALE_DRAG;
-            break;
-#    endif  // POINTING_DEVICE_ENABLE
-#    ifdef MIDI_ENABLE
-        case KNOB_MODE_MIDI:
-            delta *= knob_config.sensitivity * KNOB_SENS_SCALE_MIDI;
-            break;
-#    endif  // MIDI_ENABLE
+    // apply dual rate
+    if (knob_config.dual_rate) {
+        delta = knob_dual_rate(delta, elapsed);
     }
 
-    // apply reverse
-    if (knob_config.reverse) {
-        delta *= -1;
+    // fan out; motion waits in each sink until its next output
+    for (uint8_t i = 0; i < KNOB_SINK_COUNT; i++) {
+        if (knob_params.sink_mode[i] == KNOB_MODE_OFF) {
+            continue;
+        }
+        knob_sink_state_t* sink = &knob_state.sinks[i];
+        sink->moved = (sink->due && sink->moved) || delta_fine != 0;
+        sink->pending += delta;
+        sink->due = true;
     }
+}
+
+// returns false if the sink's output is not due yet, otherwise consumes its pending motion
+static bool knob_sink_delta(uint8_t index, int* delta_truncated) {
+    knob_sink_state_t* sink = &knob_state.sinks[index];
+
+    // pace outputs, at most once per action
+    if (!sink->due || TIMER_DIFF_32(current_time, sink->last_output_time) < knob_params.sink_pace_ms[index]) {
+        return false;
+    }
+    sink->last_output_time = current_time;
+    sink->due = false;
+
+    // apply sensitivity and reverse
+    float delta = sink->pending * knob_params.sink_scale[index];
+    sink->pending = 0;
 
     // truncate to integer and save remainder
-    delta += knob_state.remainder;
-    int delta_truncated = delta;
-    knob_state.remainder = delta - delta_truncated;
-    
-    // apply action
-#    ifdef POINTING_DEVICE_ENABLE
-    report_mouse_t mouse;
-#    endif  // POINTING_DEVICE_ENABLE
-    switch (knob_config.mode) {
+    delta += sink->remainder;
+    *delta_truncated = delta;
+    sink->remainder = delta - *delta_truncated;
+    return true;
+}
+
+static void knob_sink_action(knob_mode_t mode, int delta_truncated) {
+    switch (mode) {
 #    ifdef ENCODER_ENABLE
         case KNOB_MODE_ENCODER:
             while (delta_truncated > 0) {
@@ -317,117 +809,571 @@ static void housekeeping_task_knob_modes(void) {
             }
             break;
 #    endif  // ENCODER_ENABLE
+#    ifdef MIDI_ENABLE
+        case KNOB_MODE_MIDI:
+            if (knob_config.midi_mode == MIDI_MODE_ABSOLUTE_14) {
+                midi_send_absolute_cc14(delta_truncated, knob_config.midi_channel, knob_config.midi_cc);
+            } else {
+                midi_send_relative_cc(delta_truncated, knob_config.midi_channel, knob_config.midi_cc, knob_config.midi_mode);
+            }
+            break;
+#    endif  // MIDI_ENABLE
+        default:
+            break;  // unreachable
+    }
+}
+
+static void housekeeping_task_knob_modes(void) {
+
+    // avoid repeated timer reads by doing it once and saving the value
+    current_time = timer_read32();
+
+    // reset state after a period of no activity; a momentum glide is activity
+    // too, it needs the action slots until it has decayed
+    if (as5600_delta_fine == 0) {
+        bool idle = TIMER_DIFF_32(current_time, knob_state.last_motion_time) > knob_config.timeout_ms;
 #    ifdef POINTING_DEVICE_ENABLE
-        case KNOB_MODE_WHEEL_VERTICAL...KNOB_MODE_DRAG_DIAGONAL: 
-            if (delta_truncated == 0) {
-                break;
+        idle = idle && !knob_state.momentum_coasting;
+#    endif  // POINTING_DEVICE_ENABLE
+        if (idle) {
+            reset_knob_state();
+            return;
+        }
+    } else {
+        knob_state.accumulator += as5600_delta_fine;
+        knob_state.last_motion_time = current_time;
+#    ifdef POINTING_DEVICE_ENABLE
+        // touching the knob stops any momentum scrolling
+        if (knob_state.momentum_coasting) {
+            knob_state.momentum_coasting = false;
+            knob_state.momentum_velocity = 0;
+            knob_state.momentum_position = 0;
+        }
+#    endif  // POINTING_DEVICE_ENABLE
+    }
+
+    // a pointing main mode acts when the pointing device task asks for a report;
+    // with the knob off, the slot only delivers events
+    if (knob_params.pointing_sink != 0) {
+        knob_action_slot();
+    }
+
+    // apply actions, pointing sinks are served by the pointing device driver
+    for (uint8_t i = 0; i < KNOB_SINK_COUNT; i++) {
+        knob_mode_t mode = knob_params.sink_mode[i];
+        int delta_truncated;
+        if (mode == KNOB_MODE_OFF || is_pointing_mode(mode) || !knob_sink_delta(i, &delta_truncated)) {
+            continue;
+        }
+        knob_sink_action(mode, delta_truncated);
+    }
+}
+
+// ============================================================================
+// POINTING DEVICE DRIVER
+// ============================================================================
+
+#    ifdef POINTING_DEVICE_ENABLE
+
+// tracks wheel output in 1/256 units per action; once the knob stops faster
+// than the release threshold, keeps scrolling with the velocity decayed by the
+// friction factor every action, all in integer math
+static int knob_momentum(int delta_truncated, bool moved) {
+
+    // while the knob turns, follow its output
+    if (moved) {
+        knob_state.momentum_velocity = (knob_state.momentum_velocity + ((int32_t)delta_truncated << 8)) / 2;
+        return delta_truncated;
+    }
+
+    // the knob just stopped, coast only after a flick
+    if (!knob_state.momentum_coasting) {
+        if (labs(knob_state.momentum_velocity) < knob_params.momentum_threshold) {
+            knob_state.momentum_velocity = 0;
+            return delta_truncated;
+        }
+        knob_state.momentum_coasting = true;
+        knob_state.momentum_position = 0;
+    }
+
+    // decay and integrate
+    knob_state.momentum_velocity = knob_state.momentum_velocity * knob_config.momentum_friction / 256;
+    knob_state.momentum_position += knob_state.momentum_velocity;
+    int32_t step = knob_state.momentum_position / 256;
+    knob_state.momentum_position -= step * 256;
+    if (knob_state.momentum_velocity == 0) {
+        knob_state.momentum_coasting = false;
+    }
+    return delta_truncated + step;
+}
+
+static report_mouse_t knob_drag_move(report_mouse_t mouse, knob_mode_t mode, int delta_truncated) {
+    switch (mode) {
+        case KNOB_MODE_DRAG_VERTICAL:
+        case KNOB_MODE_ADAPTIVE_DRAG_VERTICAL:
+            mouse.y += delta_truncated * -1;
+            break;
+        case KNOB_MODE_DRAG_HORIZONTAL:
+        case KNOB_MODE_ADAPTIVE_DRAG_HORIZONTAL:
+            mouse.x += delta_truncated;
+            break;
+        case KNOB_MODE_DRAG_DIAGONAL:
+        case KNOB_MODE_ADAPTIVE_DRAG_DIAGONAL:
+            mouse.y += delta_truncated * -1;
+            mouse.x += delta_truncated;
+            break;
+        default:
+            break;  // unreachable
+    }
+    return mouse;
+}
+
+// smoothed time between actions with motion, the inverse of the knob's speed
+static void knob_drag_track_motion(void) {
+    uint32_t gap = TIMER_DIFF_32(current_time, knob_state.drag_motion_time);
+    uint32_t longest = (uint32_t)knob_config.drag_off_delay * KNOB_ADAPTIVE_DRAG_OFF_RANGE;
+    if (gap > longest) {
+        gap = longest;
+    }
+    knob_state.drag_interval = (3 * (uint32_t)knob_state.drag_interval + gap) / 4;
+    knob_state.drag_motion_time = current_time;
+}
+
+// the knob has stopped once it stays still for a few of its recent motion
+// intervals: soon after a decisive stop, later during slow fine adjustment.
+// a fast turn has motion in every slot, so its interval is the throttle; with
+// the defaults that releases after 3 * 16 = 48 ms, about half of drag_off_delay,
+// and the drag_off_delay / range floor only takes over below a 9 ms throttle
+static uint32_t knob_drag_release_delay(void) {
+    uint32_t delay = (uint32_t)knob_state.drag_interval * KNOB_ADAPTIVE_DRAG_OFF_GAPS;
+    uint32_t shortest = knob_config.drag_off_delay / KNOB_ADAPTIVE_DRAG_OFF_RANGE;
+    uint32_t longest = (uint32_t)knob_config.drag_off_delay * KNOB_ADAPTIVE_DRAG_OFF_RANGE;
+    if (delay < shortest) {
+        return shortest;
+    }
+    if (delay > longest) {
+        return longest;
+    }
+    return delay;
+}
+
+// presses the button on the first motion; motion during the engage delay is
+// buffered and replayed once the press has settled, so none of it is lost
+static report_mouse_t knob_adaptive_drag(report_mouse_t mouse, knob_mode_t mode, int delta_truncated, bool moved) {
+    switch (knob_state.drag_state) {
+        case DRAG_STATE_DEACTIVATED:
+            if (delta_truncated != 0) {
+                knob_state.drag_state = DRAG_STATE_ACTIVATING;
+                knob_state.drag_time = current_time;
+                knob_state.drag_motion_time = current_time;
+                knob_state.drag_interval = knob_config.drag_off_delay / KNOB_ADAPTIVE_DRAG_OFF_GAPS;
+                knob_state.drag_replay = delta_truncated;
+                start_dragging();
+            }
+            return mouse;
+        case DRAG_STATE_ACTIVATING:
+            knob_state.drag_replay += delta_truncated;
+            if (moved) {
+                knob_drag_track_motion();
             }
-            mouse = pointing_device_get_report();
-            switch (knob_config.mode) {
-                case KNOB_MODE_WHEEL_VERTICAL:
-                    mouse.v += delta_truncated * -1;
-                    break;
-                case KNOB_MODE_WHEEL_HORIZONTAL:
-                    mouse.h += delta_truncated;
-                    break;
-                case KNOB_MODE_DRAG_VERTICAL:
-                    mouse.y += delta_truncated * -1;
-                    break;
-                case KNOB_MODE_DRAG_HORIZONTAL:
-                    mouse.x += delta_truncated;
-                    break;
-                case KNOB_MODE_DRAG_DIAGONAL:
-                    mouse.y += delta_truncated * -1;
-                    mouse.x += delta_truncated;
-                    break;
-                default:
-                    return;  // unreachable
+            if (TIMER_DIFF_32(current_time, knob_state.drag_time) < knob_config.drag_on_delay) {
+                return mouse;
+            }
+            knob_state.drag_state = DRAG_STATE_ACTIVATED;
+            delta_truncated = knob_state.drag_replay;
+            knob_state.drag_replay = 0;
+            break;
+        case DRAG_STATE_ACTIVATED:
+            if (moved) {
+                knob_drag_track_motion();
+            } else if (TIMER_DIFF_32(current_time, knob_state.drag_motion_time) >= knob_drag_release_delay()) {
+                knob_state.drag_state = DRAG_STATE_DEACTIVATED;
+                stop_dragging();
+                return mouse;
             }
-            pointing_device_set_report(mouse);
+            break;
+    }
+    return knob_drag_move(mouse, mode, delta_truncated);
+}
+
+static report_mouse_t knob_pointing_action(report_mouse_t mouse, knob_mode_t mode, int delta_truncated, bool moved) {
+    switch (mode) {
+        case KNOB_MODE_WHEEL_VERTICAL:
+            mouse.v += delta_truncated * -1;
+            break;
+        case KNOB_MODE_WHEEL_HORIZONTAL:
+            mouse.h += delta_truncated;
+            break;
+        case KNOB_MODE_DRAG_VERTICAL...KNOB_MODE_DRAG_DIAGONAL:
+            mouse = knob_drag_move(mouse, mode, delta_truncated);
             break;
         case KNOB_MODE_ADAPTIVE_DRAG_VERTICAL...KNOB_MODE_ADAPTIVE_DRAG_DIAGONAL:
-            switch (knob_state.drag_state) {
-                case DRAG_STATE_DEACTIVATED:
-                    if (delta_truncated != 0) {
-                        knob_state.drag_state = DRAG_STATE_ACTIVATING;
-                        knob_state.drag_time = current_time;
-                        start_dragging();
-                    }
-                    break;
-                case DRAG_STATE_ACTIVATING:
-                    if (TIMER_DIFF_32(current_time, knob_state.drag_time) >= KNOB_ADAPTIVE_DRAG_ON_DELAY) {
-                        knob_state.drag_state = DRAG_STATE_ACTIVATED;
-                    }
-                    break;
-                case DRAG_STATE_ACTIVATED:
-                    if (delta_truncated != 0) {
-                        knob_state.drag_time = current_time;
-                        mouse = pointing_device_get_report();
-                        switch (knob_config.mode) {
-                            case KNOB_MODE_ADAPTIVE_DRAG_VERTICAL:
-                                mouse.y += delta_truncated * -1;
-                                break;
-                            case KNOB_MODE_ADAPTIVE_DRAG_HORIZONTAL:
-                                mouse.x += delta_truncated;
-                                break;
-                            case KNOB_MODE_ADAPTIVE_DRAG_DIAGONAL:
-                                mouse.y += delta_truncated * -1;
-                                mouse.x += delta_truncated;
-                                break;
-                            default:
-                                return;  // unreachable
-                        }
-                        pointing_device_set_report(mouse);
-                    } else {
-                        if (TIMER_DIFF_32(current_time, knob_state.drag_time) >= KNOB_ADAPTIVE_DRAG_OFF_DELAY) {
-                            knob_state.drag_state = DRAG_STATE_DEACTIVATED;
-                            stop_dragging();
-                        }
-                    }
-                    break;
+            mouse = knob_adaptive_drag(mouse, mode, delta_truncated, moved);
+            break;
+        default:
+            break;  // unreachable
+    }
+    return mouse;
+}
+
+// POINTING_DEVICE_DRIVER = custom: motion is produced right when the pointing
+// device task builds the report, and drag buttons are merged in the same place
+bool custom_pointing_device_init(void) {
+    return true;
+}
+
+report_mouse_t custom_pointing_device_get_report(report_mouse_t mouse) {
+    int8_t sink = knob_params.pointing_sink;
+#        ifdef KNOB_CALIBRATION_ENABLE
+    // the calibration holds every output
+    if (knob_calibration_state.active) {
+        sink = -1;
+    }
+#        endif  // KNOB_CALIBRATION_ENABLE
+    if (sink >= 0) {
+        current_time = timer_read32();
+        if (sink == 0) {
+            knob_action_slot();
+        }
+        knob_mode_t mode = knob_params.sink_mode[sink];
+        bool moved = knob_state.sinks[sink].moved;
+        int delta_truncated;
+        if (knob_sink_delta(sink, &delta_truncated)) {
+            if (knob_config.momentum && (KNOB_MODE_WHEEL_VERTICAL <= mode) && (mode <= KNOB_MODE_WHEEL_HORIZONTAL)) {
+                delta_truncated = knob_momentum(delta_truncated, moved);
+            }
+            mouse = knob_pointing_action(mouse, mode, delta_truncated, moved);
+        }
+    }
+    return drag_merge_buttons(mouse);
+}
+
+uint16_t custom_pointing_device_get_cpi(void) {
+    return 0;
+}
+
+void custom_pointing_device_set_cpi(uint16_t cpi) {}
+
+#    endif  // POINTING_DEVICE_ENABLE
+
+// ============================================================================
+// RGB SCHEDULER
+// ============================================================================
+
+#    ifdef RGBLIGHT_ENABLE
+
+// ws2812 frames are bit-banged with interrupts disabled, so color requests are
+// coalesced here and only pushed when they can't delay a sensor read or report
+typedef struct {
+    uint8_t hue;
+    uint8_t sat;
+    uint8_t val;
+    uint8_t hue_offset;
+    bool dirty;
+    bool enable;
+    bool enable_dirty;
+    bool animation_paused;
+    uint8_t flash_hue;
+    bool flash_pending;
+    bool flashing;
+    uint8_t covered_hue;
+    uint8_t covered_sat;
+    uint8_t covered_val;
+    uint32_t last_frame_time;
+} rgb_scheduler_t;
+
+rgb_scheduler_t rgb_scheduler = {0};
+
+void knob_rgb_sethsv(uint8_t hue, uint8_t sat, uint8_t val) {
+    rgb_scheduler.hue = hue;
+    rgb_scheduler.sat = sat;
+    rgb_scheduler.val = val;
+    rgb_scheduler.dirty = true;
+}
+
+void knob_rgb_enable(bool enable) {
+    rgb_scheduler.enable = enable;
+    rgb_scheduler.enable_dirty = true;
+}
+
+void knob_rgb_flash(uint8_t hue) {
+    rgb_scheduler.flash_hue = hue;
+    rgb_scheduler.flash_pending = true;
+}
+
+static uint8_t knob_rgb_hue_offset(void) {
+    switch (knob_config.rgb_reactive) {
+        case KNOB_RGB_REACTIVE_POSITION:
+            return as5600_raw >> 4;
+        case KNOB_RGB_REACTIVE_VELOCITY: {
+            uint16_t offset = knob_state.speed * KNOB_RGB_VELOCITY_SCALE;
+            return offset > 255 ? 255 : offset;
+        }
+        default:
+            return 0;
+    }
+}
+
+static void housekeeping_task_rgb(void) {
+
+    // while the knob is moving, only push frames in the gap after an action
+    bool busy = knob_params.active && TIMER_DIFF_32(current_time, knob_state.last_motion_time) <= knob_config.throttle_ms;
+
+    // the calibration times every sample, a late read would skew the fit
+#        ifdef KNOB_CALIBRATION_ENABLE
+    bool calibrating = knob_calibration_state.active;
+#        else
+    bool calibrating = false;
+#        endif  // KNOB_CALIBRATION_ENABLE
+
+    // animated effects write frames on their own timer, so hold them while busy
+#        ifdef RGBLIGHT_USE_TIMER
+    if ((busy || calibrating) && !rgb_scheduler.animation_paused && rgblight_is_enabled() && rgblight_get_mode() > RGBLIGHT_MODE_STATIC_LIGHT) {
+        rgblight_timer_disable();
+        rgb_scheduler.animation_paused = true;
+    } else if (!busy && !calibrating && rgb_scheduler.animation_paused) {
+        rgblight_timer_enable();
+        rgb_scheduler.animation_paused = false;
+    }
+#        endif  // RGBLIGHT_USE_TIMER
+
+    // cap the frame rate
+    if (TIMER_DIFF_32(current_time, rgb_scheduler.last_frame_time) < KNOB_RGB_FRAME_MS) {
+        return;
+    }
+
+    // pointing reports and midi messages from an action are already out by now, but
+    // queued encoder events are only sent by the next loop's encoder task; either
+    // way the frame has to finish before the next action is due
+    if (busy) {
+        uint32_t since_action = TIMER_DIFF_32(current_time, knob_state.last_action_time);
+        if ((since_action == 0 && knob_params.encoder_sink) || since_action + KNOB_RGB_GAP_MS >= knob_config.throttle_ms) {
+            return;
+        }
+    }
+
+    // switching on or off writes a frame of its own, the color follows on the next one
+    if (rgb_scheduler.enable_dirty) {
+        rgb_scheduler.enable_dirty = false;
+        if (rgb_scheduler.enable != rgblight_is_enabled()) {
+            if (rgb_scheduler.enable) {
+                rgblight_enable_noeeprom();
+            } else {
+                rgblight_disable_noeeprom();
             }
+            rgb_scheduler.last_frame_time = current_time;
+            return;
+        }
+    }
+
+    // rgblight drops color changes while it is off, keep them for when it comes back
+    if (!rgblight_is_enabled()) {
+        rgb_scheduler.flash_pending = false;
+        return;
+    }
+
+    // a flash covers the color for KNOB_RGB_FLASH_MS, then the covered color is put back
+    if (rgb_scheduler.flash_pending) {
+        if (!rgb_scheduler.flashing) {
+            rgb_scheduler.covered_hue = rgblight_get_hue();
+            rgb_scheduler.covered_sat = rgblight_get_sat();
+            rgb_scheduler.covered_val = rgblight_get_val();
+        }
+        rgblight_sethsv_noeeprom(rgb_scheduler.flash_hue, 255, rgb_scheduler.covered_val);
+        rgb_scheduler.flash_pending = false;
+        rgb_scheduler.flashing = true;
+        rgb_scheduler.last_frame_time = current_time;
+        return;
+    }
+    if (rgb_scheduler.flashing) {
+        if (TIMER_DIFF_32(current_time, rgb_scheduler.last_frame_time) < KNOB_RGB_FLASH_MS) {
+            return;
+        }
+        rgb_scheduler.flashing = false;
+        rgblight_sethsv_noeeprom(rgb_scheduler.covered_hue, rgb_scheduler.covered_sat, rgb_scheduler.covered_val);
+        rgb_scheduler.last_frame_time = current_time;
+        return;
+    }
+
+    // flashes are the only frames drawn during a calibration
+    if (calibrating) {
+        return;
+    }
+
+    // skip the frame if nothing would change
+    uint8_t hue_offset = knob_rgb_hue_offset();
+    if (!rgb_scheduler.dirty && hue_offset == rgb_scheduler.hue_offset) {
+        return;
+    }
+
+    // reactive-only frames keep whatever saturation and brightness were set elsewhere (e.g. via)
+    if (rgb_scheduler.dirty) {
+        rgblight_sethsv_noeeprom(rgb_scheduler.hue + hue_offset, rgb_scheduler.sat, rgb_scheduler.val);
+    } else {
+        rgblight_sethsv_noeeprom(rgb_scheduler.hue + hue_offset, rgblight_get_sat(), rgblight_get_val());
+    }
+    rgb_scheduler.hue_offset = hue_offset;
+    rgb_scheduler.dirty = false;
+    rgb_scheduler.last_frame_time = current_time;
+}
+
+#    endif  // RGBLIGHT_ENABLE
+
+// ============================================================================
+// PUBLIC KNOB API
+// ============================================================================
+
+static float knob_sensitivity_scale(knob_mode_t mode, uint8_t sensitivity, bool reverse) {
+    float sensitivity_scale = 0;
+    switch (mode) {
+        case KNOB_MODE_OFF:
+            break;
+#    ifdef ENCODER_ENABLE
+        case KNOB_MODE_ENCODER:
+            sensitivity_scale = sensitivity * KNOB_SENS_SCALE_ENCODER;
+            break;
+#    endif  // ENCODER_ENABLE
+#    ifdef POINTING_DEVICE_ENABLE
+        case KNOB_MODE_WHEEL_VERTICAL...KNOB_MODE_WHEEL_HORIZONTAL:
+            sensitivity_scale = sensitivity * KNOB_SENS_SCALE_WHEEL;
+            break;
+        case KNOB_MODE_DRAG_VERTICAL...KNOB_MODE_ADAPTIVE_DRAG_DIAGONAL:
+            sensitivity_scale = sensitivity * KNOB_SENS_SCALE_DRAG;
             break;
 #    endif  // POINTING_DEVICE_ENABLE
 #    ifdef MIDI_ENABLE
         case KNOB_MODE_MIDI:
-            midi_send_relative_cc(delta_truncated, knob_config.midi_channel, knob_config.midi_cc, knob_config.midi_mode);
+            if (knob_config.midi_mode == MIDI_MODE_ABSOLUTE_14) {
+                sensitivity_scale = sensitivity * KNOB_SENS_SCALE_MIDI_14;
+            } else {
+                sensitivity_scale = sensitivity * KNOB_SENS_SCALE_MIDI;
+            }
             break;
 #    endif  // MIDI_ENABLE
-        default:
-            return;  // unreachable
     }
-    return;
+    if (reverse) {
+        sensitivity_scale *= -1;
+    }
+    return sensitivity_scale;
 }
 
-// ============================================================================
-// PUBLIC KNOB API
-// ============================================================================
+// two sinks of the same kind would fight over one output
+static bool knob_sinks_conflict(knob_mode_t a, knob_mode_t b) {
+    return a == b || (is_pointing_mode(a) && is_pointing_mode(b));
+}
 
-void set_knob_mode(knob_mode_t mode) {
+static void update_knob_params(void) {
+
+    // acceleration curve coefficients
+    float scale = knob_config.acceleration_scale < 1 ? 1 : knob_config.acceleration_scale;
+    knob_params.acceleration_p = knob_config.acceleration_blend / scale;
+    knob_params.acceleration_q = knob_config.acceleration_blend + 1.0f;
+    knob_params.acceleration_r = scale;
+
+    // dual rate switching points and crossfade rate
+    int32_t hysteresis = (int32_t)knob_config.dual_rate_threshold * KNOB_DUAL_RATE_HYSTERESIS / 100;
+    knob_params.dual_rate_fine_speed = knob_config.dual_rate_threshold - hysteresis;
+    knob_params.dual_rate_coarse_speed = knob_config.dual_rate_threshold + hysteresis;
+    knob_params.dual_rate_gain_span = knob_config.dual_rate_coarse_gain - knob_config.dual_rate_fine_gain;
+    knob_params.dual_rate_blend_per_ms = 1.0f / KNOB_DUAL_RATE_CROSSFADE_MS;
+
+#    ifdef POINTING_DEVICE_ENABLE
+    // momentum release threshold, in the same 1/256 units as the tracked velocity
+    knob_params.momentum_threshold = (int32_t)knob_config.momentum_threshold << 8;
+#    endif  // POINTING_DEVICE_ENABLE
+
+    // the main mode acts on every action
+    knob_params.sink_mode[0] = knob_config.mode;
+    knob_params.sink_scale[0] = knob_sensitivity_scale(knob_config.mode, knob_config.sensitivity, knob_config.reverse);
+    knob_params.sink_pace_ms[0] = 0;
+
+    // extra sinks, dropping any that duplicate an earlier one
+    for (uint8_t i = 1; i < KNOB_SINK_COUNT; i++) {
+        const knob_sink_config_t* sink = &knob_config.sinks[i - 1];
+        knob_mode_t mode = sink->mode;
+        for (uint8_t j = 0; j < i && mode != KNOB_MODE_OFF; j++) {
+            if (knob_sinks_conflict(knob_params.sink_mode[j], mode)) {
+                mode = KNOB_MODE_OFF;
+            }
+        }
+        knob_params.sink_mode[i] = mode;
+        knob_params.sink_scale[i] = knob_sensitivity_scale(mode, sink->sensitivity, sink->reverse);
+        knob_params.sink_pace_ms[i] = sink->pace_ms;
+    }
+
+    knob_params.pointing_sink = -1;
+    knob_params.encoder_sink = false;
+    knob_params.active = false;
+    for (uint8_t i = 0; i < KNOB_SINK_COUNT; i++) {
+        if (is_pointing_mode(knob_params.sink_mode[i])) {
+            knob_params.pointing_sink = i;
+        }
+#    ifdef ENCODER_ENABLE
+        knob_params.encoder_sink |= knob_params.sink_mode[i] == KNOB_MODE_ENCODER;
+#    endif  // ENCODER_ENABLE
+        knob_params.active |= knob_params.sink_mode[i] != KNOB_MODE_OFF;
+    }
+
+#    ifdef MIDI_ENABLE
+    // a new channel, cc or mode must not jump to the old controller's value
+    if (knob_config.midi_mode != MIDI_MODE_ABSOLUTE_14 || knob_config.midi_channel != midi_value_14.channel || knob_config.midi_cc != midi_value_14.cc) {
+        midi_value_14.value = 8192;
+        midi_value_14.channel = knob_config.midi_channel;
+        midi_value_14.cc = knob_config.midi_cc;
+    }
+#    endif  // MIDI_ENABLE
+}
+
+// lets go of the previous config's outputs before a new one is applied
+static void knob_release_outputs(void) {
 #    ifdef POINTING_DEVICE_ENABLE
-    if ((KNOB_MODE_DRAG_VERTICAL <= knob_config.mode) && (knob_config.mode <= KNOB_MODE_DRAG_DIAGONAL)) {
+    if (knob_state.drag_buttons != 0) {
         stop_dragging();
     }
+    knob_state.momentum_coasting = false;
+    knob_state.momentum_velocity = 0;
+    knob_state.momentum_position = 0;
 #    endif  // POINTING_DEVICE_ENABLE
     reset_knob_state();
-    knob_config.mode = mode;
+}
+
+static void knob_engage_outputs(void) {
+#    ifdef KNOB_CALIBRATION_ENABLE
+    // a config applied mid-calibration is engaged once the calibration stops
+    if (knob_calibration_state.active) {
+        return;
+    }
+#    endif  // KNOB_CALIBRATION_ENABLE
 #    ifdef POINTING_DEVICE_ENABLE
-    if ((KNOB_MODE_DRAG_VERTICAL <= knob_config.mode) && (knob_config.mode <= KNOB_MODE_DRAG_DIAGONAL)) {
+    if (knob_params.pointing_sink < 0) {
+        return;
+    }
+    knob_mode_t mode = knob_params.sink_mode[knob_params.pointing_sink];
+    if ((KNOB_MODE_DRAG_VERTICAL <= mode) && (mode <= KNOB_MODE_DRAG_DIAGONAL)) {
         start_dragging();
     }
-    if ((KNOB_MODE_ADAPTIVE_DRAG_VERTICAL <= knob_config.mode) && (knob_config.mode <= KNOB_MODE_ADAPTIVE_DRAG_DIAGONAL)) {
+    if ((KNOB_MODE_ADAPTIVE_DRAG_VERTICAL <= mode) && (mode <= KNOB_MODE_ADAPTIVE_DRAG_DIAGONAL)) {
         knob_state.drag_state = DRAG_STATE_DEACTIVATED;
     }
 #    endif  // POINTING_DEVICE_ENABLE
 }
 
+void set_knob_mode(knob_mode_t mode) {
+    knob_release_outputs();
+    knob_config.mode = mode;
+    update_knob_params();
+    knob_engage_outputs();
+}
+
 knob_config_t get_knob_config(void) {
     return knob_config;
 }
 
 void set_knob_config(knob_config_t config) {
-    set_knob_mode(config.mode);
+    knob_release_outputs();
     knob_config = config;
+    update_knob_params();
+    knob_engage_outputs();
 }
 
 void reset_knob_config(void) {
@@ -449,10 +1395,59 @@ void keyboard_pre_init_kb(void){
     keyboard_pre_init_user();
 }
 
+void keyboard_post_init_kb(void) {
+#ifdef KNOB_CALIBRATION_ENABLE
+    knob_calibration_load();
+#endif // KNOB_CALIBRATION_ENABLE
+#if !defined(KNOB_MINIMAL) && defined(RGBLIGHT_ENABLE)
+    if (!rgb_scheduler.dirty) {
+        rgb_scheduler.hue = rgblight_get_hue();
+        rgb_scheduler.sat = rgblight_get_sat();
+        rgb_scheduler.val = rgblight_get_val();
+    }
+#endif // !KNOB_MINIMAL && RGBLIGHT_ENABLE
+    keyboard_post_init_user();
+}
+
+#ifdef KNOB_CALIBRATION_ENABLE
+// the kb datablock is cleared along with the rest of the eeprom
+void eeconfig_init_kb(void) {
+    memset(as5600_correction, 0, sizeof(as5600_correction));
+    eeconfig_init_user();
+}
+#endif // KNOB_CALIBRATION_ENABLE
+
+bool process_record_kb(uint16_t keycode, keyrecord_t* record) {
+#ifdef KNOB_CALIBRATION_ENABLE
+    if (keycode == KNOB_CAL) {
+        if (record->event.pressed) {
+            knob_calibration_start();
+        }
+        return false;
+    }
+#endif // KNOB_CALIBRATION_ENABLE
+    return process_record_user(keycode, record);
+}
+
 void housekeeping_task_kb(void) {
     housekeeping_task_read_as5600();
+#ifdef KNOB_CALIBRATION_ENABLE
+    if (knob_calibration_task()) {
+#    if !defined(KNOB_MINIMAL) && defined(RGBLIGHT_ENABLE)
+        current_time = timer_read32();
+        housekeeping_task_rgb();
+#    endif // !KNOB_MINIMAL && RGBLIGHT_ENABLE
+        housekeeping_task_user();
+        return;
+    }
+#endif // KNOB_CALIBRATION_ENABLE
 #ifndef KNOB_MINIMAL
     housekeeping_task_knob_modes();
+#    ifdef RGBLIGHT_ENABLE
+    housekeeping_task_rgb();
+#    endif // RGBLIGHT_ENABLE
+#else
+    housekeeping_task_knob_events();
 #endif // !KNOB_MINIMAL
     housekeeping_task_user();
 }
@@ -8,6 +8,27 @@
 uint16_t get_as5600_raw(void);
 int16_t get_as5600_delta(void);
 
+#ifdef KNOB_CALIBRATION_ENABLE
+enum knob_keycodes {
+    KNOB_CAL = QK_KB_0,
+};
+
+// starts fitting the angle correction; turn the knob steadily for KNOB_CAL_TURNS + 1 full turns
+void knob_calibration_start(void);
+#endif  // KNOB_CALIBRATION_ENABLE
+
+// batched motion, delivered once per action slot
+typedef struct {
+    int16_t delta;           // filtered sensor counts since the last event
+    int32_t velocity;        // smoothed, in counts per second
+    uint32_t time;           // timer_read32() at the slot
+    bool direction_changed;  // first motion against the previous direction
+} knob_event_t;
+
+// return false to consume the event, otherwise the built-in mode acts on it
+bool knob_event_kb(knob_event_t* event);
+bool knob_event_user(knob_event_t* event);
+
 #ifndef KNOB_MINIMAL
 
 typedef enum {
@@ -35,23 +56,59 @@ typedef enum {
     MIDI_MODE_SIGNED,
     MIDI_MODE_OFFSET,
     MIDI_MODE_TWOS,
+    MIDI_MODE_ABSOLUTE_14,
 } midi_mode_t;
 #    endif  // MIDI_ENABLE
 
+#    ifdef RGBLIGHT_ENABLE
+typedef enum {
+    KNOB_RGB_REACTIVE_OFF = 0,
+    KNOB_RGB_REACTIVE_POSITION,
+    KNOB_RGB_REACTIVE_VELOCITY,
+} knob_rgb_reactive_t;
+#    endif  // RGBLIGHT_ENABLE
+
+// an extra output driven by the same filtered, accelerated motion as the main
+// mode, with its own scale and pacing; only one sink of each kind (encoder,
+// pointing, midi) is driven, and the main mode comes first
+typedef struct {
+    knob_mode_t mode;
+    uint8_t sensitivity;
+    bool reverse;
+    uint16_t pace_ms;  // 0 = every action
+} knob_sink_config_t;
+
 typedef struct {
     knob_mode_t mode;
     uint8_t sensitivity;
     bool acceleration;
     bool reverse;
+    uint16_t throttle_ms;
+    uint16_t timeout_ms;
+    float acceleration_scale;
+    float acceleration_blend;
+    bool dual_rate;
+    uint16_t dual_rate_threshold;
+    float dual_rate_fine_gain;
+    float dual_rate_coarse_gain;
 #    ifdef POINTING_DEVICE_ENABLE
     pointing_device_buttons_t drag_button;
     uint8_t drag_modifiers;
+    uint16_t drag_on_delay;
+    uint16_t drag_off_delay;
+    bool momentum;
+    uint8_t momentum_friction;
+    uint16_t momentum_threshold;
 #    endif  // POINTING_DEVICE_ENABLE
 #    ifdef MIDI_ENABLE
     uint8_t midi_channel;
     uint8_t midi_cc;
     midi_mode_t midi_mode;
 #    endif  // MIDI_ENABLE
+#    ifdef RGBLIGHT_ENABLE
+    knob_rgb_reactive_t rgb_reactive;
+#    endif  // RGBLIGHT_ENABLE
+    knob_sink_config_t sinks[KNOB_EXTRA_SINKS];
 } knob_config_t;
 
 static const knob_config_t default_knob_config = {
@@ -59,19 +116,45 @@ static const knob_config_t default_knob_config = {
     .sensitivity = 10,
     .acceleration = false,
     .reverse = false,
+    .throttle_ms = KNOB_THROTTLE_MS,
+    .timeout_ms = KNOB_TIMEOUT_MS,
+    .acceleration_scale = KNOB_ACCELERATION_SCALE,
+    .acceleration_blend = KNOB_ACCELERATION_BLEND,
+    .dual_rate = false,
+    .dual_rate_threshold = KNOB_DUAL_RATE_THRESHOLD,
+    .dual_rate_fine_gain = KNOB_DUAL_RATE_FINE_GAIN,
+    .dual_rate_coarse_gain = KNOB_DUAL_RATE_COARSE_GAIN,
 #    ifdef POINTING_DEVICE_ENABLE
     .drag_button = POINTING_DEVICE_BUTTON1,
     .drag_modifiers = 0,
+    .drag_on_delay = KNOB_ADAPTIVE_DRAG_ON_DELAY,
+    .drag_off_delay = KNOB_ADAPTIVE_DRAG_OFF_DELAY,
+    .momentum = false,
+    .momentum_friction = KNOB_MOMENTUM_FRICTION,
+    .momentum_threshold = KNOB_MOMENTUM_THRESHOLD,
 #    endif  // POINTING_DEVICE_ENABLE
 #    ifdef MIDI_ENABLE
     .midi_channel = 0,
     .midi_cc = 0,
     .midi_mode = MIDI_MODE_SIGNED,
 #    endif
+#    ifdef RGBLIGHT_ENABLE
+    .rgb_reactive = KNOB_RGB_REACTIVE_OFF,
+#    endif  // RGBLIGHT_ENABLE
+    .sinks = {{.mode = KNOB_MODE_OFF}},
 };
 
 knob_config_t get_knob_config(void);
 void set_knob_config(knob_config_t config);
 void reset_knob_config(void);
 
+#    ifdef RGBLIGHT_ENABLE
+// queues a backlight color change; the frame is pushed by the knob's rgb scheduler
+void knob_rgb_sethsv(uint8_t hue, uint8_t sat, uint8_t val);
+// briefly shows a fully saturated hue over the backlight color
+void knob_rgb_flash(uint8_t hue);
+// queues switching the backlight on or off, without touching the eeprom
+void knob_rgb_enable(bool enable);
+#    endif  // RGBLIGHT_ENABLE
+
 #endif  // !KNOB_MINIMAL
\ No newline at end of file
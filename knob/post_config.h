@@ -1,8 +1,65 @@
 // Copyright 2025 Morgan Newell Sun (@eynsai)
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#ifndef KNOB_THROTTLE_MS
+#    define KNOB_THROTTLE_MS 16
+#endif
+
+#ifdef KNOB_OVERSAMPLE_ENABLE
+#    ifndef KNOB_OVERSAMPLE_SHIFT
+#        define KNOB_OVERSAMPLE_SHIFT 2
+#    endif
+#    if KNOB_OVERSAMPLE_SHIFT < 1
+#        error "KNOB_OVERSAMPLE_SHIFT must be at least 1"
+#    endif
+#    define KNOB_FRACTION_BITS 4
+#    ifndef KNOB_BACKLASH
+#        define KNOB_BACKLASH (1 << (KNOB_FRACTION_BITS - 1))
+#    endif
+#else
+#    define KNOB_FRACTION_BITS 0
+#    define KNOB_BACKLASH 1
+#endif
+
+#define KNOB_FRACTION_SCALE (1.0f / (1 << KNOB_FRACTION_BITS))
+
+#ifdef KNOB_CALIBRATION_ENABLE
+#    ifndef KNOB_CAL_BINS_SHIFT
+#        define KNOB_CAL_BINS_SHIFT 5
+#    endif
+#    define KNOB_CAL_BINS (1 << KNOB_CAL_BINS_SHIFT)
+#    ifndef KNOB_CAL_TURNS
+#        define KNOB_CAL_TURNS 2
+#    endif
+#    ifndef KNOB_CAL_TIMEOUT_MS
+#        define KNOB_CAL_TIMEOUT_MS 5000
+#    endif
+#    ifndef KNOB_CAL_STEADY_PERCENT
+#        define KNOB_CAL_STEADY_PERCENT 20
+#    endif
+#    ifndef KNOB_CAL_HUE_START
+#        define KNOB_CAL_HUE_START 170
+#    endif
+#    ifndef KNOB_CAL_HUE_DONE
+#        define KNOB_CAL_HUE_DONE 85
+#    endif
+#    ifndef KNOB_CAL_HUE_ABORT
+#        define KNOB_CAL_HUE_ABORT 0
+#    endif
+#    ifndef EECONFIG_KB_DATA_SIZE
+#        define EECONFIG_KB_DATA_SIZE (2 * KNOB_CAL_BINS)
+#    endif
+#endif
+
 #ifndef KNOB_MINIMAL
 
+#    ifndef KNOB_EXTRA_SINKS
+#        define KNOB_EXTRA_SINKS 2
+#    endif
+#    if KNOB_EXTRA_SINKS < 1
+#        error "KNOB_EXTRA_SINKS must be at least 1"
+#    endif
+
 #    ifndef KNOB_TIMEOUT_MS
 #        define KNOB_TIMEOUT_MS 1000
 #    endif
@@ -11,10 +68,6 @@
 #        define KNOB_ACCELERATION_BUFFER_SIZE 10
 #    endif
 
-#    ifndef KNOB_THROTTLE_MS
-#        define KNOB_THROTTLE_MS 16
-#    endif
-
 #    ifndef KNOB_ACCELERATION_SCALE
 #        define KNOB_ACCELERATION_SCALE 100.0
 #    endif
@@ -23,6 +76,30 @@
 #        define KNOB_ACCELERATION_BLEND 0.872116
 #    endif
 
+#    ifndef KNOB_DUAL_RATE_THRESHOLD
+#        define KNOB_DUAL_RATE_THRESHOLD 512
+#    endif
+
+#    ifndef KNOB_DUAL_RATE_FINE_GAIN
+#        define KNOB_DUAL_RATE_FINE_GAIN 0.25
+#    endif
+
+#    ifndef KNOB_DUAL_RATE_COARSE_GAIN
+#        define KNOB_DUAL_RATE_COARSE_GAIN 1.0
+#    endif
+
+#    ifndef KNOB_DUAL_RATE_HYSTERESIS
+#        define KNOB_DUAL_RATE_HYSTERESIS 25
+#    endif
+
+#    ifndef KNOB_DUAL_RATE_CROSSFADE_MS
+#        define KNOB_DUAL_RATE_CROSSFADE_MS 100
+#    endif
+
+#    ifndef KNOB_DUAL_RATE_FINE_SMOOTHING
+#        define KNOB_DUAL_RATE_FINE_SMOOTHING 0.5f
+#    endif
+
 #    ifndef KNOB_ADAPTIVE_DRAG_ON_DELAY
 #        define KNOB_ADAPTIVE_DRAG_ON_DELAY 100
 #    endif
@@ -31,6 +108,22 @@
 #        define KNOB_ADAPTIVE_DRAG_OFF_DELAY 100
 #    endif
 
+#    ifndef KNOB_ADAPTIVE_DRAG_OFF_GAPS
+#        define KNOB_ADAPTIVE_DRAG_OFF_GAPS 3
+#    endif
+
+#    ifndef KNOB_ADAPTIVE_DRAG_OFF_RANGE
+#        define KNOB_ADAPTIVE_DRAG_OFF_RANGE 4
+#    endif
+
+#    ifndef KNOB_MOMENTUM_FRICTION
+#        define KNOB_MOMENTUM_FRICTION 240
+#    endif
+
+#    ifndef KNOB_MOMENTUM_THRESHOLD
+#        define KNOB_MOMENTUM_THRESHOLD 60
+#    endif
+
 #    ifndef KNOB_SENS_SCALE_ENCODER
 #        define KNOB_SENS_SCALE_ENCODER (1.0 / 4096.0)
 #    endif
@@ -47,4 +140,28 @@
 #        define KNOB_SENS_SCALE_MIDI (1.0 / 4096.0)
 #    endif
 
+#    ifndef KNOB_SENS_SCALE_MIDI_14
+#        define KNOB_SENS_SCALE_MIDI_14 (128.0 / 4096.0)
+#    endif
+
+#    ifdef RGBLIGHT_ENABLE
+
+#        ifndef KNOB_RGB_FRAME_MS
+#            define KNOB_RGB_FRAME_MS 33
+#        endif
+
+#        ifndef KNOB_RGB_GAP_MS
+#            define KNOB_RGB_GAP_MS 4
+#        endif
+
+#        ifndef KNOB_RGB_VELOCITY_SCALE
+#            define KNOB_RGB_VELOCITY_SCALE 2
+#        endif
+
+#        ifndef KNOB_RGB_FLASH_MS
+#            define KNOB_RGB_FLASH_MS 250
+#        endif
+
+#    endif  // RGBLIGHT_ENABLE
+
 #endif
\ No newline at end of file
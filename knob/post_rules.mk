@@ -0,0 +1,3 @@
+ifeq ($(strip $(KNOB_CALIBRATION_ENABLE)), yes)
+    OPT_DEFS += -DKNOB_CALIBRATION_ENABLE
+endif
@@ -0,0 +1,176 @@
+# Copyright 2025 Morgan Newell Sun (@eynsai)
+# SPDX-License-Identifier: GPL-2.0-or-later
+
+# Checks a knob's angle correction table against a recorded calibration trace.
+#
+# Record the trace with `qmk console` while the KNOB_CAL key runs a calibration
+# (debug output must be on), then run:
+#
+#     python3 check_calibration.py console.log [--fraction-bits 4]
+#
+# The firmware prints every uncorrected, unwrapped angle as
+# "knob cal trace: <ms> <angle>" and the fitted table as "knob cal table: ...".
+# This script refits the table from the trace the way the firmware does, but
+# with sub-millisecond crossing times, compares it to the stored one, and
+# reports how smoothly the angle follows time, per turn, with and without the
+# correction.
+
+import argparse
+import math
+import re
+
+TRACE_PATTERN = re.compile(r'knob cal trace: (\d+) (-?\d+)')
+TABLE_PATTERN = re.compile(r'knob cal table:((?: -?\d+)+)')
+
+
+def read_log(path):
+    trace = []
+    table = None
+    with open(path, 'r') as f:
+        for line in f:
+            match = TRACE_PATTERN.search(line)
+            if match:
+                trace.append((int(match.group(1)), int(match.group(2))))
+                continue
+            match = TABLE_PATTERN.search(line)
+            if match:
+                table = [int(v) for v in match.group(1).split()]
+    return trace, table
+
+
+def linearize(angle, table, full_range):
+    # same integer interpolation as as5600_linearize()
+    bins = len(table)
+    shift = int(math.log2(full_range // bins))
+    sample = angle % full_range
+    index = sample >> shift
+    fraction = sample & ((1 << shift) - 1)
+    low = table[index]
+    high = table[(index + 1) % bins]
+    return angle - (low + (((high - low) * fraction) >> shift))
+
+
+def split_turns(trace, full_range):
+    # consecutive windows of one full turn, in either direction
+    turns = []
+    start = 0
+    for i in range(1, len(trace)):
+        if abs(trace[i][1] - trace[start][1]) >= full_range:
+            turns.append(trace[start:i + 1])
+            start = i
+    return turns
+
+
+def solve3(m, v):
+    # cramer's rule for the 3x3 normal equations
+    def det(a):
+        return (a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+                - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+                + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]))
+    d = det(m)
+    if d == 0:
+        return [0.0, 0.0, 0.0]
+    result = []
+    for column in range(3):
+        replaced = [[v[r] if c == column else m[r][c] for c in range(3)] for r in range(3)]
+        result.append(det(replaced) / d)
+    return result
+
+
+def straightness(turn, correct):
+    # rms and peak deviation from a least-squares quadratic through angle over
+    # time, since a hand's speed drifts over a turn but that is no sensor error
+    points = [(t - turn[0][0], correct(a)) for t, a in turn]
+    n = len(points)
+    span = max(points[-1][0], 1)
+    powers = [[(t / span) ** k for k in range(3)] for t, _ in points]
+    m = [[sum(p[r] * p[c] for p in powers) for c in range(3)] for r in range(3)]
+    v = [sum(p[r] * a for p, (_, a) in zip(powers, points)) for r in range(3)]
+    coefficients = solve3(m, v)
+    residuals = [a - sum(k * x for k, x in zip(coefficients, p)) for p, (_, a) in zip(powers, points)]
+    rms = math.sqrt(sum(r * r for r in residuals) / n)
+    return rms, max(abs(r) for r in residuals)
+
+
+def steady(time, nominal, percent):
+    return abs(time - nominal) <= nominal * percent / 100
+
+
+def refit(trace, bins, full_range, percent):
+    # crossing time of each bin boundary, interpolated between samples, against
+    # where the speed trend between consecutive turns would have put the knob;
+    # like knob_calibration_fit_turn(), the first steady turn is only the
+    # reference and unsteady turns are skipped
+    width = full_range // bins
+    direction = 1 if trace[-1][1] > trace[0][1] else -1
+    crossings = []
+    for (t0, a0), (t1, a1) in zip(trace, trace[1:]):
+        if (a1 - a0) * direction <= 0:
+            continue
+        for boundary in range(min(a0, a1) // width + 1, max(a0, a1) // width + 1):
+            position = boundary * width
+            crossings.append((t0 + (t1 - t0) * (position - a0) / (a1 - a0), position))
+    sums = [0.0] * bins
+    count = 0
+    previous = None
+    for start in range(0, len(crossings) - bins, bins):
+        turn = crossings[start:start + bins + 1]
+        start_time, start_position = turn[0]
+        turn_time = turn[-1][0] - start_time
+        intervals = [b[0] - a[0] for a, b in zip(turn, turn[1:])]
+        if not all(steady(i, turn_time / bins, percent) for i in intervals):
+            previous = None
+            continue
+        reference, previous = previous, turn_time
+        if reference is None or not steady(turn_time, reference, percent):
+            continue
+        trend = (reference - turn_time) * turn_time / (reference * (reference + turn_time))
+        errors = []
+        for time, position in turn[:bins]:
+            x = (time - start_time) / turn_time
+            expected = start_position + direction * full_range * (x + trend * x * (x - 1))
+            errors.append((position % full_range // width, position - expected))
+        mean = sum(e for _, e in errors) / bins
+        for index, error in errors:
+            sums[index] += error - mean
+        count += 1
+    return [s / count for s in sums] if count else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Check a knob angle correction table against a recorded trace.')
+    parser.add_argument('log', help='console output captured during calibration')
+    parser.add_argument('--fraction-bits', type=int, default=0, help='KNOB_FRACTION_BITS of the firmware (4 with KNOB_OVERSAMPLE_ENABLE)')
+    parser.add_argument('--steady-percent', type=int, default=20, help='KNOB_CAL_STEADY_PERCENT of the firmware')
+    parser.add_argument('--table', help='comma-separated table to check instead of the one in the log')
+    args = parser.parse_args()
+
+    full_range = 4096 << args.fraction_bits
+    scale = 1.0 / (1 << args.fraction_bits)
+    trace, table = read_log(args.log)
+    if args.table:
+        table = [int(v) for v in args.table.split(',')]
+    if not trace:
+        raise SystemExit('no trace lines found')
+    if not table:
+        raise SystemExit('no table found, pass one with --table')
+
+    turns = split_turns(trace, full_range)
+    print(f'{len(trace)} samples, {len(turns)} full turns, {len(table)} bins')
+    if not turns:
+        raise SystemExit('the trace does not cover a full turn')
+
+    print('turn  rms before  peak before  rms after  peak after  (counts)')
+    for i, turn in enumerate(turns):
+        rms_before, peak_before = straightness(turn, lambda a: a)
+        rms_after, peak_after = straightness(turn, lambda a: linearize(a, table, full_range))
+        print(f'{i:4d}  {rms_before * scale:10.2f}  {peak_before * scale:11.2f}  {rms_after * scale:9.2f}  {peak_after * scale:10.2f}')
+
+    fitted = refit(trace, len(table), full_range, args.steady_percent)
+    if fitted:
+        differences = [abs(a - b) for a, b in zip(table, fitted)]
+        print(f'table vs refit: max difference {max(differences) * scale:.2f} counts, at bin {differences.index(max(differences))}')
+
+
+if __name__ == '__main__':
+    main()